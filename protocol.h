@@ -0,0 +1,65 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+/* Mouse protocol definitions shared by the driver and the usbmon analyzer. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VENDOR_ID  0x258A
+#define PRODUCT_ID 0x1007
+
+/* Used for control transfer */
+#define DIR_IN 0xA1
+#define DIR_OUT	0x21
+#define REQ_IN 1
+#define REQ_OUT	9
+#define VALUE_DPI_CONFIG 0x0304
+#define VALUE_MACRO_N_BTN_FUNS 0x0306
+#define VALUE_CURRENT_MODES 0x0308
+#define TRANSFER_INDEX 0x0001
+#define TRANSFER_TIMEOUT 1000
+
+#define NUM_OF_BUTTONS 7
+#define NUM_OF_UNK_BUTTONS 3
+#define NUM_OF_BUTTON_FUNS 14
+#define BUTTON_SIZE 4
+
+#define DPI_CONFIG_LEN 59
+#define CURRENT_MODES_LEN 9
+#define MACRO_N_BTN_FUNS_LEN 1145
+#define MAX_MACRO_SIZE 1022
+
+/* "some_data" struct members represent data, which I did not research, because
+ * they are not essential for this driver to work.
+ */
+typedef struct {
+	uint8_t some_data1[2];
+	uint8_t active_dpi_mode_count;
+	uint8_t some_data2[2];
+	uint8_t dpi_value[6];
+	uint8_t some_data3[33];
+	uint8_t logo_color[6];
+	uint8_t some_data4[9];
+} DpiInfo;
+
+typedef struct {
+	size_t bytes_written;			/* Bytes written in macro buffer. */
+	uint16_t num_of_cycles;			/* How many times to loop macro. */
+	uint8_t macro[MAX_MACRO_SIZE];
+} MacroInfo;
+
+typedef struct {
+	uint8_t some_data1[2];
+	uint8_t poll_rate;
+	uint8_t some_data2[2];
+	uint8_t dpi_mode;
+	uint8_t some_data3[3];
+} ModesInfo;
+
+typedef struct {
+	uint8_t fun;
+	uint8_t args[3];
+} MouseBtnInfo;
+
+#endif
@@ -0,0 +1,798 @@
+/* usbmon capture analyzer for SINOWEALTH Genesis Xenon 750 (258a:1007).
+ * Extracts configuration control transfers from usbmon captures, decodes them
+ * with the driver's structs and shows which bytes change between transfers.
+ *
+ * Copyright (C) 2024 jokerzmn <jokerzmnvv@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * See LICENSE file for copyright and license details.
+ */
+
+#include "usbmon_analyzer.h"
+#include "default_mouse_data.h"
+
+#define LEN(x) (sizeof(x) / sizeof((x)[0]))
+#define FIELD(type, member) { #member, offsetof(type, member), sizeof(((type *)0)->member), 1 }
+
+/* Layout of the macro and button functionalities buffer,
+ * see fill_macro_n_btn_funs_buf() in driver.c.
+ */
+#define BTNS_FUN_LEN ((NUM_OF_BUTTONS + NUM_OF_UNK_BUTTONS) * BUTTON_SIZE)
+#define NUM_OF_CYCLES_OFFSET 1
+#define MACRO_OFFSET 3
+#define BTNS_FUN_OFFSET (MACRO_OFFSET + MAX_MACRO_SIZE)
+#define REP_BTNS_FUN_1_OFFSET (BTNS_FUN_OFFSET + BTNS_FUN_LEN)
+#define REP_BTNS_FUN_2_OFFSET (REP_BTNS_FUN_1_OFFSET + BTNS_FUN_LEN)
+
+static bool quiet;
+static bool dev_addr_given;
+static bool start_ts_set;
+static int64_t start_ts_sec;
+static int32_t start_ts_usec;
+static UsbAddr mouse_devs[MAX_MOUSE_DEVS];
+static size_t num_of_mouse_devs;
+static PendingUrb pending_urbs[MAX_PENDING_URBS];
+static size_t next_pending_urb;
+
+static const FieldInfo dpi_info_fields[] = {
+	FIELD(DpiInfo, some_data1),
+	FIELD(DpiInfo, active_dpi_mode_count),
+	FIELD(DpiInfo, some_data2),
+	FIELD(DpiInfo, dpi_value),
+	FIELD(DpiInfo, some_data3),
+	FIELD(DpiInfo, logo_color),
+	FIELD(DpiInfo, some_data4)
+};
+
+static const FieldInfo modes_info_fields[] = {
+	FIELD(ModesInfo, some_data1),
+	FIELD(ModesInfo, poll_rate),
+	FIELD(ModesInfo, some_data2),
+	FIELD(ModesInfo, dpi_mode),
+	FIELD(ModesInfo, some_data3)
+};
+
+static const FieldInfo macro_n_btn_funs_fields[] = {
+	{ "header", 0, 1, 1 },
+	{ "num_of_cycles", NUM_OF_CYCLES_OFFSET, 2, 1 },
+	{ "macro", MACRO_OFFSET, MAX_MACRO_SIZE, 1 },
+	{ "btns_fun", BTNS_FUN_OFFSET, BTNS_FUN_LEN, BUTTON_SIZE },
+	{ "rep_btns_fun_1", REP_BTNS_FUN_1_OFFSET, BTNS_FUN_LEN, BUTTON_SIZE },
+	{ "rep_btns_fun_2", REP_BTNS_FUN_2_OFFSET, BTNS_FUN_LEN, BUTTON_SIZE }
+};
+
+/* Every report the driver sends can also be read back from the mouse,
+ * so each of them is tracked separately for both directions.
+ */
+static ReportStream streams[NUM_OF_REPORTS] = {
+	{ .req_type = DIR_OUT, .value = VALUE_DPI_CONFIG, .len = DPI_CONFIG_LEN,
+	  .name = "SET_REPORT dpi_config", .fields = dpi_info_fields,
+	  .num_of_fields = LEN(dpi_info_fields), .decode = decode_dpi_config },
+	{ .req_type = DIR_OUT, .value = VALUE_CURRENT_MODES, .len = CURRENT_MODES_LEN,
+	  .name = "SET_REPORT current_modes", .fields = modes_info_fields,
+	  .num_of_fields = LEN(modes_info_fields), .decode = decode_modes },
+	{ .req_type = DIR_OUT, .value = VALUE_MACRO_N_BTN_FUNS, .len = MACRO_N_BTN_FUNS_LEN,
+	  .name = "SET_REPORT macro_n_btn_funs", .fields = macro_n_btn_funs_fields,
+	  .num_of_fields = LEN(macro_n_btn_funs_fields), .decode = decode_macro_n_btn_funs },
+	{ .req_type = DIR_IN, .value = VALUE_DPI_CONFIG, .len = DPI_CONFIG_LEN,
+	  .name = "GET_REPORT dpi_config", .fields = dpi_info_fields,
+	  .num_of_fields = LEN(dpi_info_fields), .decode = decode_dpi_config },
+	{ .req_type = DIR_IN, .value = VALUE_CURRENT_MODES, .len = CURRENT_MODES_LEN,
+	  .name = "GET_REPORT current_modes", .fields = modes_info_fields,
+	  .num_of_fields = LEN(modes_info_fields), .decode = decode_modes },
+	{ .req_type = DIR_IN, .value = VALUE_MACRO_N_BTN_FUNS, .len = MACRO_N_BTN_FUNS_LEN,
+	  .name = "GET_REPORT macro_n_btn_funs", .fields = macro_n_btn_funs_fields,
+	  .num_of_fields = LEN(macro_n_btn_funs_fields), .decode = decode_macro_n_btn_funs }
+};
+
+void
+add_mouse_dev(UsbAddr addr)
+{
+	if (is_mouse_dev(addr) || num_of_mouse_devs == MAX_MOUSE_DEVS)
+		return;
+
+	mouse_devs[num_of_mouse_devs++] = addr;
+}
+
+/* Remember submitted URB, so its callback can be matched with the request.
+ * Oldest URB is overwritten when there are too many pending URBs.
+ * URB ids are kernel pointers and get reused, so a stale URB with the same
+ * id is released first.
+ */
+void
+add_pending_urb(const UsbmonPacket *pkt, UsbAddr addr)
+{
+	PendingUrb *urb;
+
+	take_pending_urb(pkt, addr);
+
+	urb = &pending_urbs[next_pending_urb++ % MAX_PENDING_URBS];
+	urb->used = true;
+	urb->id = pkt->id;
+	urb->addr = addr;
+	memcpy(urb->setup, pkt->setup, SETUP_LEN);
+	urb->length = pkt->length;
+	urb->payload = pkt->payload;
+	urb->payload_len = pkt->payload_len;
+}
+
+void
+decode_dpi_config(const uint8_t *buf)
+{
+	DpiInfo info;
+	size_t i;
+
+	memcpy(&info, buf, sizeof(info));
+
+	printf("\tactive_dpi_mode_count: %u\n", info.active_dpi_mode_count);
+	printf("\tdpi_value:");
+	for (i = 0; i < LEN(info.dpi_value); ++i)
+		printf(" %u%s", (info.dpi_value[i] & 0x7F) * 100, (info.dpi_value[i] & 0x80) ? "(off)" : "");
+	putchar('\n');
+
+	print_bytes("logo_color", info.logo_color, sizeof(info.logo_color));
+	print_bytes("some_data1", info.some_data1, sizeof(info.some_data1));
+	print_bytes("some_data2", info.some_data2, sizeof(info.some_data2));
+	print_bytes("some_data3", info.some_data3, sizeof(info.some_data3));
+	print_bytes("some_data4", info.some_data4, sizeof(info.some_data4));
+}
+
+/* Macro length is not part of the buffer, so it is shown as the number of bytes
+ * up to the last non-zero byte of the macro.
+ */
+void
+decode_macro_n_btn_funs(const uint8_t *buf)
+{
+	const uint8_t *p_macro = &buf[MACRO_OFFSET];
+	size_t macro_len = MAX_MACRO_SIZE;
+
+	while (macro_len > 0 && p_macro[macro_len - 1] == 0)
+		macro_len--;
+
+	printf("\theader: %02x\n", buf[0]);
+	printf("\tnum_of_cycles: %u\n", (buf[NUM_OF_CYCLES_OFFSET] << 8) | buf[NUM_OF_CYCLES_OFFSET + 1]);
+	printf("\tmacro: %zu bytes\n", macro_len);
+	print_btns("btns_fun", &buf[BTNS_FUN_OFFSET]);
+	print_btns("rep_btns_fun_1", &buf[REP_BTNS_FUN_1_OFFSET]);
+	print_btns("rep_btns_fun_2", &buf[REP_BTNS_FUN_2_OFFSET]);
+}
+
+void
+decode_modes(const uint8_t *buf)
+{
+	ModesInfo info;
+
+	memcpy(&info, buf, sizeof(info));
+
+	if (info.poll_rate >= 1 && info.poll_rate <= 4)
+		printf("\tpoll_rate: %u (%uHz)\n", info.poll_rate, 125U << (info.poll_rate - 1));
+	else
+		printf("\tpoll_rate: %u\n", info.poll_rate);
+
+	printf("\tdpi_mode: %u\n", info.dpi_mode);
+	print_bytes("some_data1", info.some_data1, sizeof(info.some_data1));
+	print_bytes("some_data2", info.some_data2, sizeof(info.some_data2));
+	print_bytes("some_data3", info.some_data3, sizeof(info.some_data3));
+}
+
+/* Compare payload with the previous payload of the same report byte by byte.
+ * The first payload of each report is compared with the data the driver
+ * would send by default; those differences are not counted in the summary.
+ */
+void
+diff_payload(ReportStream *stream, const uint8_t *payload)
+{
+	char name[64];
+	size_t i, changed = 0;
+	bool first = !stream->seen;
+
+	if (first) {
+		fill_default_payload(stream, stream->last);
+		stream->seen = true;
+	}
+	if (!quiet)
+		printf("\t%s:\n", first ? "differences from driver defaults" : "changes");
+
+	for (i = 0; i < stream->len; ++i) {
+		if (payload[i] == stream->last[i])
+			continue;
+
+		changed++;
+		if (!first)
+			stream->changes[i]++;
+		if (!quiet) {
+			get_field_name(stream, i, name, sizeof(name));
+			printf("\t\t0x%04zx  %-28s %02x -> %02x\n", i, name, stream->last[i], payload[i]);
+		}
+	}
+	if (!quiet && changed == 0)
+		puts("\t\tnone");
+
+	memcpy(stream->last, payload, stream->len);
+}
+
+/* Fill buf with data the driver transfers when config file is empty. */
+void
+fill_default_payload(const ReportStream *stream, uint8_t *buf)
+{
+	switch (stream->value) {
+	case VALUE_DPI_CONFIG:
+		memcpy(buf, default_dpi_data, sizeof(default_dpi_data));
+		break;
+	case VALUE_CURRENT_MODES:
+		memcpy(buf, default_modes_data, sizeof(default_modes_data));
+		break;
+	case VALUE_MACRO_N_BTN_FUNS:
+		memset(buf, 0, MACRO_N_BTN_FUNS_LEN);
+		buf[0] = 0x06;
+		memcpy(&buf[BTNS_FUN_OFFSET], default_btns_fun, BTNS_FUN_LEN);
+		memcpy(&buf[REP_BTNS_FUN_1_OFFSET], default_btns_fun, BTNS_FUN_LEN);
+		memcpy(&buf[REP_BTNS_FUN_2_OFFSET], default_btns_fun, BTNS_FUN_LEN);
+		break;
+	}
+}
+
+ReportStream *
+find_report_stream(uint8_t req_type, uint16_t value)
+{
+	int i;
+
+	for (i = 0; i < NUM_OF_REPORTS; ++i) {
+		if (streams[i].req_type == req_type && streams[i].value == value)
+			return &streams[i];
+	}
+	return NULL;
+}
+
+void
+get_field_name(const ReportStream *stream, size_t offset, char *name, size_t name_len)
+{
+	const FieldInfo *field;
+	size_t i, rel;
+
+	for (i = 0; i < stream->num_of_fields; ++i) {
+		field = &stream->fields[i];
+
+		if (offset < field->offset || offset >= field->offset + field->size)
+			continue;
+
+		rel = offset - field->offset;
+		if (field->size == 1)
+			snprintf(name, name_len, "%s", field->name);
+		else if (field->elem_size == BUTTON_SIZE && rel % BUTTON_SIZE == 0)
+			snprintf(name, name_len, "%s[%zu].fun", field->name, rel / BUTTON_SIZE);
+		else if (field->elem_size == BUTTON_SIZE)
+			snprintf(name, name_len, "%s[%zu].args[%zu]", field->name, rel / BUTTON_SIZE, rel % BUTTON_SIZE - 1);
+		else
+			snprintf(name, name_len, "%s[%zu]", field->name, rel);
+		return;
+	}
+	snprintf(name, name_len, "?");
+}
+
+/* Mouse is recognized by its device descriptor, which is read by the host
+ * when the mouse is plugged in. Descriptor reads at address 0 during
+ * enumeration are skipped, because the device gets a new address afterwards.
+ * If the capture was started after that and no bus and device number were
+ * given, the first device sending one of the driver's reports with a matching
+ * length is assumed to be the mouse.
+ */
+void
+handle_control_packet(const UsbmonPacket *pkt)
+{
+	UsbAddr addr = { pkt->busnum, pkt->devnum };
+	UsbmonPacket out_pkt;
+	ReportStream *stream;
+	PendingUrb *urb;
+	uint8_t req_type, req;
+	uint16_t value, index, length;
+
+	if (pkt->type == 'S' && pkt->has_setup) {
+		req_type = pkt->setup[0];
+		req = pkt->setup[1];
+		value = pkt->setup[2] | (pkt->setup[3] << 8);
+		index = pkt->setup[4] | (pkt->setup[5] << 8);
+		length = pkt->setup[6] | (pkt->setup[7] << 8);
+
+		if (req_type == DIR_GET_DESCRIPTOR && req == REQ_GET_DESCRIPTOR && (value >> 8) == DEV_DESC_TYPE) {
+			if (!dev_addr_given && addr.devnum != 0)
+				add_pending_urb(pkt, addr);
+			return;
+		}
+		if ((req_type != DIR_OUT || req != REQ_OUT) && (req_type != DIR_IN || req != REQ_IN))
+			return;
+		if (!(stream = find_report_stream(req_type, value)))
+			return;
+		if (!is_mouse_dev(addr)) {
+			if (dev_addr_given || num_of_mouse_devs > 0)
+				return;
+			if (index != TRANSFER_INDEX || length != stream->len)
+				return;
+
+			add_mouse_dev(addr);
+			if (!quiet)
+				printf("No device descriptor of %04x:%04x in capture, assuming device %u:%u is the mouse.\n",
+						VENDOR_ID, PRODUCT_ID, addr.busnum, addr.devnum);
+		}
+
+		add_pending_urb(pkt, addr);
+		return;
+	}
+
+	if (pkt->type == 'E') {
+		take_pending_urb(pkt, addr);
+		return;
+	}
+	if (pkt->type != 'C' || !(urb = take_pending_urb(pkt, addr)))
+		return;
+
+	req = urb->setup[1];
+	value = urb->setup[2] | (urb->setup[3] << 8);
+
+	if (req == REQ_GET_DESCRIPTOR) {
+		if (pkt->status != 0 || pkt->payload_len < DEV_DESC_ID_LEN
+				|| pkt->payload[0] != DEV_DESC_LEN || pkt->payload[1] != DEV_DESC_TYPE)
+			return;
+		if ((pkt->payload[8] | (pkt->payload[9] << 8)) == VENDOR_ID
+				&& (pkt->payload[10] | (pkt->payload[11] << 8)) == PRODUCT_ID)
+			add_mouse_dev(addr);
+		else
+			remove_mouse_dev(addr);
+		return;
+	}
+
+	/* Reports are handled only when the mouse accepted the transfer.
+	 * Data of SET_REPORT is part of the submission, not of the callback.
+	 */
+	if (pkt->status != 0 || !is_mouse_dev(addr) || !(stream = find_report_stream(urb->setup[0], value)))
+		return;
+
+	if (urb->setup[0] == DIR_OUT) {
+		out_pkt = *pkt;
+		out_pkt.length = urb->length;
+		out_pkt.payload = urb->payload;
+		out_pkt.payload_len = urb->payload_len;
+		handle_report(stream, &out_pkt, addr);
+	}
+	else
+		handle_report(stream, pkt, addr);
+}
+
+void
+handle_report(ReportStream *stream, const UsbmonPacket *pkt, UsbAddr addr)
+{
+	int64_t sec = pkt->ts_sec - start_ts_sec;
+	int32_t usec = pkt->ts_usec - start_ts_usec;
+
+	if (usec < 0) {
+		sec--;
+		usec += 1000000;
+	}
+	if (!quiet)
+		printf("[%lld.%06d] %u:%u %s (%zu/%u bytes)\n", (long long)sec, (int)usec,
+				addr.busnum, addr.devnum, stream->name, pkt->payload_len, stream->len);
+
+	/* Incomplete payloads can not be decoded nor compared reliably.
+	 * Payload is truncated when capture holds less data than the URB transferred,
+	 * otherwise the transfer itself was shorter than the report.
+	 */
+	if (pkt->payload_len < stream->len) {
+		if (!quiet && pkt->payload_len < pkt->length)
+			puts("\tpayload truncated, increase snapshot length of the capture");
+		else if (!quiet)
+			puts("\tshort transfer, payload is shorter than the report");
+		return;
+	}
+
+	stream->transfers++;
+	if (!quiet)
+		stream->decode(pkt->payload);
+	diff_payload(stream, pkt->payload);
+}
+
+bool
+is_mouse_dev(UsbAddr addr)
+{
+	size_t i;
+
+	for (i = 0; i < num_of_mouse_devs; ++i) {
+		if (mouse_devs[i].busnum == addr.busnum && mouse_devs[i].devnum == addr.devnum)
+			return true;
+	}
+	return false;
+}
+
+/* Capture is mapped instead of read, so captures of several GB are streamed
+ * through with sequential readahead and without copying them into buffers.
+ */
+result
+map_capture(const char *path, Capture *cap)
+{
+	struct stat st;
+	void *data;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		perror(path);
+		return ERR_OPEN_CAPTURE;
+	}
+	if (fstat(fd, &st) != 0) {
+		perror(path);
+		close(fd);
+		return ERR_OPEN_CAPTURE;
+	}
+	if (st.st_size == 0) {
+		fputs("unknown capture format, expected pcap or raw usbmon binary data\n", stderr);
+		close(fd);
+		return ERR_UNKNOWN_FORMAT;
+	}
+
+	data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		perror(path);
+		return ERR_MAP_CAPTURE;
+	}
+	posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+	cap->data = data;
+	cap->size = (size_t)st.st_size;
+	cap->pos = 0;
+	return SUC;
+}
+
+/* Layout of a pcap record (pcap file header is skipped by open_capture()):
+ * - record header (16 bytes), where bytes 9-12 = number of captured bytes,
+ * - usbmon packet header (48 or 64 bytes, depends on link type),
+ * - captured data.
+ * Layout of a raw usbmon record:
+ * - usbmon packet header (48 bytes), as written by read() on /dev/usbmonN,
+ * - captured data (length taken from the header).
+ * Layout of usbmon packet header (see Documentation/usb/usbmon.rst in kernel):
+ * - bytes 1-8 = URB id,
+ * - byte 9 = event type ('S' - submission, 'C' - callback, 'E' - error),
+ * - byte 10 = transfer type, byte 11 = endpoint, byte 12 = device number,
+ * - bytes 13-14 = bus number,
+ * - byte 15 = 0 when setup packet is present,
+ * - bytes 17-24 = seconds, bytes 25-28 = microseconds,
+ * - bytes 29-32 = status,
+ * - bytes 33-36 = length of data requested or transferred by URB,
+ * - bytes 37-40 = number of captured data bytes,
+ * - bytes 41-48 = setup packet.
+ */
+result
+next_packet(Capture *cap, UsbmonPacket *pkt)
+{
+	const uint8_t *hdr;
+	size_t left = cap->size - cap->pos;
+	size_t data_len, len_cap;
+
+	if (left == 0)
+		return ERR;
+
+	if (cap->pcap) {
+		if (left < PCAP_REC_HDR_LEN)
+			return ERR_CORRUPT_CAPTURE;
+
+		data_len = rd_u32(&cap->data[cap->pos + 8], cap->swapped);
+		left -= PCAP_REC_HDR_LEN;
+		if (data_len > left || data_len < cap->usbmon_hdr_len)
+			return ERR_CORRUPT_CAPTURE;
+
+		hdr = &cap->data[cap->pos + PCAP_REC_HDR_LEN];
+		data_len -= cap->usbmon_hdr_len;
+		cap->pos += PCAP_REC_HDR_LEN + cap->usbmon_hdr_len + data_len;
+	}
+	else {
+		if (left < cap->usbmon_hdr_len)
+			return ERR_CORRUPT_CAPTURE;
+
+		hdr = &cap->data[cap->pos];
+		data_len = rd_u32(&hdr[36], cap->swapped);
+		if (data_len > left - cap->usbmon_hdr_len)
+			return ERR_CORRUPT_CAPTURE;
+
+		cap->pos += cap->usbmon_hdr_len + data_len;
+	}
+
+	pkt->type = hdr[8];
+	pkt->xfer_type = hdr[9];
+
+	/* Only control transfers are of interest, skip parsing the rest. */
+	if (pkt->xfer_type != XFER_TYPE_CONTROL)
+		return SUC;
+
+	pkt->id = rd_u64(&hdr[0], cap->swapped);
+	pkt->epnum = hdr[10];
+	pkt->devnum = hdr[11];
+	pkt->busnum = rd_u16(&hdr[12], cap->swapped);
+	pkt->has_setup = hdr[14] == 0;
+	pkt->ts_sec = (int64_t)rd_u64(&hdr[16], cap->swapped);
+	pkt->ts_usec = (int32_t)rd_u32(&hdr[24], cap->swapped);
+	pkt->status = (int32_t)rd_u32(&hdr[28], cap->swapped);
+	pkt->length = rd_u32(&hdr[32], cap->swapped);
+	memcpy(pkt->setup, &hdr[40], SETUP_LEN);
+
+	len_cap = rd_u32(&hdr[36], cap->swapped);
+	pkt->payload = &hdr[cap->usbmon_hdr_len];
+	pkt->payload_len = (len_cap < data_len) ? len_cap : data_len;
+	return SUC;
+}
+
+/* pcap files are recognized by their magic number, everything else
+ * is treated as raw usbmon binary data written on this host
+ * (for example with cat /dev/usbmon1 > capture.bin).
+ */
+result
+open_capture(Capture *cap)
+{
+	uint32_t magic, linktype;
+
+	if (cap->size >= PCAP_HDR_LEN) {
+		magic = rd_u32(cap->data, false);
+
+		if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC)
+			cap->pcap = true;
+		else if ((magic = rd_u32(cap->data, true)) == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC) {
+			cap->pcap = true;
+			cap->swapped = true;
+		}
+	}
+
+	if (cap->pcap) {
+		linktype = rd_u32(&cap->data[20], cap->swapped) & 0xFFFF;
+
+		if (linktype == LINKTYPE_USB_LINUX)
+			cap->usbmon_hdr_len = USBMON_HDR_LEN;
+		else if (linktype == LINKTYPE_USB_LINUX_MMAPPED)
+			cap->usbmon_hdr_len = USBMON_MMAPPED_HDR_LEN;
+		else {
+			fprintf(stderr, "unsupported pcap link type %u, expected usbmon capture\n", linktype);
+			return ERR_UNSUPPORTED_LINKTYPE;
+		}
+		cap->pos = PCAP_HDR_LEN;
+		return SUC;
+	}
+
+	cap->usbmon_hdr_len = USBMON_HDR_LEN;
+	if (cap->size < cap->usbmon_hdr_len || !strchr("SCE", cap->data[8]) || cap->data[8] == 0
+			|| cap->data[9] > 3) {
+		fputs("unknown capture format, expected pcap or raw usbmon binary data\n", stderr);
+		return ERR_UNKNOWN_FORMAT;
+	}
+	return SUC;
+}
+
+result
+parse_dev_addr(const char *str, UsbAddr *addr)
+{
+	unsigned int bus, dev;
+	char end;
+
+	if (sscanf(str, "%u:%u%c", &bus, &dev, &end) != 2 || bus > 0xFFFF || dev > 0xFF)
+		return ERR;
+
+	addr->busnum = bus;
+	addr->devnum = dev;
+	return SUC;
+}
+
+void
+print_btns(const char *name, const uint8_t *buf)
+{
+	MouseBtnInfo btns[NUM_OF_BUTTONS + NUM_OF_UNK_BUTTONS];
+	size_t i;
+
+	memcpy(btns, buf, sizeof(btns));
+
+	printf("\t%s:", name);
+	for (i = 0; i < LEN(btns); ++i) {
+		if (i % BTNS_PER_LINE == 0)
+			printf("\n\t\t");
+		printf(" [%02x %02x %02x %02x]", btns[i].fun, btns[i].args[0], btns[i].args[1], btns[i].args[2]);
+	}
+	putchar('\n');
+}
+
+void
+print_bytes(const char *name, const uint8_t *buf, size_t len)
+{
+	size_t i;
+
+	printf("\t%s:", name);
+	for (i = 0; i < len; ++i) {
+		if (i > 0 && i % BYTES_PER_LINE == 0)
+			printf("\n\t\t");
+		printf(" %02x", buf[i]);
+	}
+	putchar('\n');
+}
+
+void
+print_summary(void)
+{
+	ReportStream *stream;
+	char name[64];
+	size_t i;
+	int j;
+	bool changed;
+
+	for (j = 0; j < NUM_OF_REPORTS && streams[j].transfers == 0; ++j)
+		;
+	if (j == NUM_OF_REPORTS) {
+		printf("No control transfers to %04x:%04x found.\n", VENDOR_ID, PRODUCT_ID);
+		return;
+	}
+
+	puts("\nSummary of bytes changed between successive transfers:");
+	for (j = 0; j < NUM_OF_REPORTS; ++j) {
+		stream = &streams[j];
+		changed = false;
+
+		if (stream->transfers == 0)
+			continue;
+
+		printf("%s: %lu transfer(s)\n", stream->name, stream->transfers);
+		for (i = 0; i < stream->len; ++i) {
+			if (stream->changes[i] == 0)
+				continue;
+
+			changed = true;
+			get_field_name(stream, i, name, sizeof(name));
+			printf("\t0x%04zx  %-28s changed %lu time(s)\n", i, name, stream->changes[i]);
+		}
+		if (!changed)
+			puts("\tno bytes changed");
+	}
+}
+
+void
+remove_mouse_dev(UsbAddr addr)
+{
+	size_t i;
+
+	for (i = 0; i < num_of_mouse_devs; ++i) {
+		if (mouse_devs[i].busnum == addr.busnum && mouse_devs[i].devnum == addr.devnum) {
+			mouse_devs[i] = mouse_devs[--num_of_mouse_devs];
+			return;
+		}
+	}
+}
+
+/* Find pending URB matching the callback and release it.
+ * Returned URB stays valid until the next add_pending_urb() call.
+ */
+PendingUrb *
+take_pending_urb(const UsbmonPacket *pkt, UsbAddr addr)
+{
+	PendingUrb *urb;
+	size_t i;
+
+	for (i = 0; i < MAX_PENDING_URBS; ++i) {
+		urb = &pending_urbs[i];
+
+		if (!urb->used || urb->id != pkt->id)
+			continue;
+		if (urb->addr.busnum != addr.busnum || urb->addr.devnum != addr.devnum)
+			continue;
+
+		urb->used = false;
+		return urb;
+	}
+	return NULL;
+}
+
+uint16_t
+rd_u16(const uint8_t *p, bool swapped)
+{
+	uint16_t x;
+
+	memcpy(&x, p, sizeof(x));
+	return swapped ? (uint16_t)((x >> 8) | (x << 8)) : x;
+}
+
+uint32_t
+rd_u32(const uint8_t *p, bool swapped)
+{
+	uint32_t x;
+
+	memcpy(&x, p, sizeof(x));
+	return swapped ? __builtin_bswap32(x) : x;
+}
+
+uint64_t
+rd_u64(const uint8_t *p, bool swapped)
+{
+	uint64_t x;
+
+	memcpy(&x, p, sizeof(x));
+	return swapped ? __builtin_bswap64(x) : x;
+}
+
+result
+run(const char *path)
+{
+	Capture cap = { 0 };
+	UsbmonPacket pkt;
+	result ret;
+
+	if ((ret = map_capture(path, &cap)) != SUC)
+		return ret;
+	if ((ret = open_capture(&cap)) != SUC) {
+		munmap((void *)cap.data, cap.size);
+		return ret;
+	}
+
+	while ((ret = next_packet(&cap, &pkt)) == SUC) {
+		if (pkt.xfer_type != XFER_TYPE_CONTROL)
+			continue;
+		if (!start_ts_set) {
+			start_ts_sec = pkt.ts_sec;
+			start_ts_usec = pkt.ts_usec;
+			start_ts_set = true;
+		}
+		handle_control_packet(&pkt);
+	}
+
+	if (ret == ERR_CORRUPT_CAPTURE)
+		fprintf(stderr, "capture is truncated or corrupt at byte %zu, stopping there\n", cap.pos);
+	else
+		ret = SUC;
+
+	print_summary();
+	munmap((void *)cap.data, cap.size);
+	return ret;
+}
+
+void
+usage(void)
+{
+	puts("Usage: usbmon_analyzer [OPTION...] <capture_file>\n");
+	puts("<capture_file>\t\tusbmon capture (pcap or raw usbmon binary data)");
+	puts("-d <bus>:<device>\tbus number and device number of the mouse");
+	puts("-q\t\t\tprint only the summary of changed bytes");
+}
+
+int
+main(int argc, char *argv[])
+{
+	UsbAddr addr;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:q")) != -1) {
+		switch (opt) {
+		case 'd':
+			if (parse_dev_addr(optarg, &addr) != SUC) {
+				usage();
+				return ERR;
+			}
+			add_mouse_dev(addr);
+			dev_addr_given = true;
+			break;
+		case 'q':
+			quiet = true;
+			break;
+		default:
+			usage();
+			return ERR;
+		}
+	}
+	if (optind != argc - 1) {
+		usage();
+		return ERR;
+	}
+
+	return run(argv[optind]);
+}
@@ -0,0 +1,146 @@
+#ifndef USBMON_ANALYZER_H
+#define USBMON_ANALYZER_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "protocol.h"
+
+/* Capture file formats */
+#define PCAP_MAGIC 0xA1B2C3D4
+#define PCAP_MAGIC_NSEC 0xA1B23C4D
+#define PCAP_HDR_LEN 24
+#define PCAP_REC_HDR_LEN 16
+#define LINKTYPE_USB_LINUX 189
+#define LINKTYPE_USB_LINUX_MMAPPED 220
+#define USBMON_HDR_LEN 48
+#define USBMON_MMAPPED_HDR_LEN 64
+
+/* Used for usbmon packet header */
+#define XFER_TYPE_CONTROL 2
+#define SETUP_LEN 8
+#define DIR_GET_DESCRIPTOR 0x80
+#define REQ_GET_DESCRIPTOR 6
+#define DEV_DESC_TYPE 1
+#define DEV_DESC_LEN 18
+#define DEV_DESC_ID_LEN 12			/* Bytes of device descriptor up to idProduct. */
+
+#define MAX_MOUSE_DEVS 8
+#define MAX_PENDING_URBS 64
+#define NUM_OF_REPORTS 6
+#define BTNS_PER_LINE 5
+#define BYTES_PER_LINE 16
+
+typedef enum result {
+	SUC,
+	ERR,
+	ERR_OPEN_CAPTURE,
+	ERR_MAP_CAPTURE,
+	ERR_UNKNOWN_FORMAT,
+	ERR_UNSUPPORTED_LINKTYPE,
+	ERR_CORRUPT_CAPTURE
+} result;
+
+typedef struct {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+	bool pcap;
+	bool swapped;				/* Capture was written on a host with other byte order. */
+	size_t usbmon_hdr_len;
+} Capture;
+
+/* Fields of usbmon packet header, converted to host byte order.
+ * Setup packet is kept as is, because it is always little endian.
+ */
+typedef struct {
+	uint64_t id;
+	uint8_t type;
+	uint8_t xfer_type;
+	uint8_t epnum;
+	uint8_t devnum;
+	uint16_t busnum;
+	bool has_setup;
+	int64_t ts_sec;
+	int32_t ts_usec;
+	int32_t status;
+	uint32_t length;			/* Length of data requested or transferred by URB. */
+	uint8_t setup[SETUP_LEN];
+	const uint8_t *payload;
+	size_t payload_len;
+} UsbmonPacket;
+
+typedef struct {
+	uint16_t busnum;
+	uint8_t devnum;
+} UsbAddr;
+
+typedef struct {
+	bool used;
+	uint64_t id;
+	UsbAddr addr;
+	uint8_t setup[SETUP_LEN];
+	uint32_t length;
+	const uint8_t *payload;		/* Submitted data of OUT transfers, points into capture. */
+	size_t payload_len;
+} PendingUrb;
+
+typedef struct {
+	const char *name;
+	size_t offset;
+	size_t size;
+	size_t elem_size;			/* BUTTON_SIZE for MouseBtnInfo arrays, 1 otherwise. */
+} FieldInfo;
+
+typedef struct {
+	uint8_t req_type;
+	uint16_t value;
+	uint16_t len;
+	const char *name;
+	const FieldInfo *fields;
+	size_t num_of_fields;
+	void (*decode)(const uint8_t *buf);
+	unsigned long transfers;
+	bool seen;
+	uint8_t last[MACRO_N_BTN_FUNS_LEN];
+	unsigned long changes[MACRO_N_BTN_FUNS_LEN];
+} ReportStream;
+
+void add_mouse_dev(UsbAddr addr);
+void add_pending_urb(const UsbmonPacket *pkt, UsbAddr addr);
+void decode_dpi_config(const uint8_t *buf);
+void decode_macro_n_btn_funs(const uint8_t *buf);
+void decode_modes(const uint8_t *buf);
+void diff_payload(ReportStream *stream, const uint8_t *payload);
+void fill_default_payload(const ReportStream *stream, uint8_t *buf);
+ReportStream *find_report_stream(uint8_t req_type, uint16_t value);
+void get_field_name(const ReportStream *stream, size_t offset, char *name, size_t name_len);
+void handle_control_packet(const UsbmonPacket *pkt);
+void handle_report(ReportStream *stream, const UsbmonPacket *pkt, UsbAddr addr);
+bool is_mouse_dev(UsbAddr addr);
+result map_capture(const char *path, Capture *cap);
+result next_packet(Capture *cap, UsbmonPacket *pkt);
+result open_capture(Capture *cap);
+result parse_dev_addr(const char *str, UsbAddr *addr);
+void print_btns(const char *name, const uint8_t *buf);
+void print_bytes(const char *name, const uint8_t *buf, size_t len);
+void print_summary(void);
+void remove_mouse_dev(UsbAddr addr);
+PendingUrb *take_pending_urb(const UsbmonPacket *pkt, UsbAddr addr);
+uint16_t rd_u16(const uint8_t *p, bool swapped);
+uint32_t rd_u32(const uint8_t *p, bool swapped);
+uint64_t rd_u64(const uint8_t *p, bool swapped);
+result run(const char *path);
+void usage(void);
+
+#endif